@@ -0,0 +1,439 @@
+//
+//  capture.cpp
+//  chip
+//
+//  Created by lex on 19/10/2026.
+//  Copyright © 2026 lex. All rights reserved.
+//
+
+#include "capture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+// Colors match the SDL front end.
+static const uint8_t PALETTE[] = {
+    0, 0, 0,
+    224, 119, 32
+};
+
+static PackedFrame PackFrame(const VideoMemory& pixels) {
+    PackedFrame packed{{0}};
+    size_t bit = 0;
+
+    for (auto& row : pixels) {
+        for (auto& pixel : row) {
+            if (pixel) {
+                packed[bit / 8] |= 0x80 >> (bit % 8);
+            }
+
+            ++bit;
+        }
+    }
+
+    return packed;
+}
+
+static void WriteLittleEndian(std::ostream& os, const uint32_t value, const size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        os.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static bool ReadLittleEndian(std::istream& is, uint32_t& value, const size_t bytes) {
+    value = 0;
+
+    for (size_t i = 0; i < bytes; ++i) {
+        const int byte = is.get();
+
+        if (byte == EOF) {
+            return false;
+        }
+
+        value |= static_cast<uint32_t>(byte) << (8 * i);
+    }
+
+    return true;
+}
+
+Capture::~Capture() {
+    Stop();
+}
+
+bool Capture::Start(const std::string& file) {
+    os.open(file, std::ios::binary | std::ios::trunc);
+
+    if (!os.is_open()) {
+        std::cout << "couldn't open capture file " << file << std::endl;
+        return false;
+    }
+
+    os.write(CAPTURE_MAGIC, 4);
+    os.put(CAPTURE_VERSION);
+    os.put(VIDEO_MEMORY_COLUMNS);
+    os.put(VIDEO_MEMORY_ROWS);
+
+    if (!ring) {
+        ring.reset(new Slot[CAPTURE_RING_SIZE]);
+    }
+
+    previous.fill(0);
+    head = 0;
+    tail = 0;
+    frameCounter = 0;
+    writtenFrames = 0;
+    droppedFrames = 0;
+    failed = false;
+
+    running = true;
+    worker = std::thread(&Capture::Work, this);
+
+    return true;
+}
+
+bool Capture::PushFrame(const VideoMemory& frame) {
+    const uint32_t frameNumber = frameCounter++;
+
+    if (!running) {
+        return false;
+    }
+
+    if (!Enqueue(frameNumber, frame)) {
+        ++droppedFrames;
+        return false;
+    }
+
+    return true;
+}
+
+bool Capture::TryPushFrame(const VideoMemory& frame) {
+    if (!running || !Enqueue(frameCounter, frame)) {
+        return false;
+    }
+
+    ++frameCounter;
+
+    return true;
+}
+
+bool Capture::Enqueue(const uint32_t frame, const VideoMemory& pixels) {
+    const size_t currentHead = head.load(std::memory_order_relaxed);
+    const size_t nextHead = (currentHead + 1) % CAPTURE_RING_SIZE;
+
+    if (nextHead == tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    ring[currentHead].frame = frame;
+    ring[currentHead].pixels = pixels;
+    head.store(nextHead, std::memory_order_release);
+
+    return true;
+}
+
+bool Capture::Stop() {
+    if (!worker.joinable()) {
+        return !failed;
+    }
+
+    running = false;
+    worker.join();
+    os.close();
+
+    if (os.fail() && !failed) {
+        std::cout << "couldn't close capture file" << std::endl;
+        failed = true;
+    }
+
+    return !failed;
+}
+
+uint32_t Capture::GetWrittenFrames() const {
+    return writtenFrames;
+}
+
+uint32_t Capture::GetDroppedFrames() const {
+    return droppedFrames;
+}
+
+void Capture::Work() {
+    uint32_t pendingFrames = 0;
+
+    while (true) {
+        // Read the flag before the ring so frames pushed right before Stop() are still drained.
+        const bool stopping = !running;
+        const size_t currentTail = tail.load(std::memory_order_relaxed);
+
+        if (currentTail == head.load(std::memory_order_acquire)) {
+            // Caught up, so hand what has been encoded so far to the file.
+            Flush(pendingFrames);
+
+            if (stopping) {
+                break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // After a write error keep draining the ring so producers waiting on it don't stall.
+        if (!failed) {
+            Encode(ring[currentTail]);
+            ++pendingFrames;
+
+            if (!os.good()) {
+                Flush(pendingFrames);
+            }
+        }
+
+        tail.store((currentTail + 1) % CAPTURE_RING_SIZE, std::memory_order_release);
+    }
+}
+
+void Capture::Flush(uint32_t& pendingFrames) {
+    if (failed || pendingFrames == 0) {
+        return;
+    }
+
+    if (!os.flush()) {
+        std::cout << "couldn't write capture file, " << pendingFrames << " frames lost" << std::endl;
+        failed = true;
+        return;
+    }
+
+    writtenFrames += pendingFrames;
+    pendingFrames = 0;
+}
+
+void Capture::Encode(const Slot& slot) {
+    const PackedFrame packed = PackFrame(slot.pixels);
+
+    // Consecutive frames mostly match, so the XOR is mostly zeroes and runs collapse well.
+    std::array<uint8_t, CAPTURE_FRAME_SIZE * 2> payload;
+    size_t payloadSize = 0;
+    size_t i = 0;
+
+    while (i < CAPTURE_FRAME_SIZE) {
+        const uint8_t value = packed[i] ^ previous[i];
+        size_t count = 1;
+
+        while (i + count < CAPTURE_FRAME_SIZE && count < 255 && (packed[i + count] ^ previous[i + count]) == value) {
+            ++count;
+        }
+
+        payload[payloadSize++] = static_cast<uint8_t>(count);
+        payload[payloadSize++] = value;
+        i += count;
+    }
+
+    WriteLittleEndian(os, slot.frame, 4);
+    WriteLittleEndian(os, static_cast<uint32_t>(payloadSize), 2);
+    os.write(reinterpret_cast<const char*>(payload.data()), payloadSize);
+
+    previous = packed;
+}
+
+// PNG writing without zlib: the image data goes into stored (uncompressed) deflate blocks.
+// At one bit per pixel the files stay small enough.
+
+static uint32_t Crc32(const uint8_t* data, const size_t size, uint32_t crc = 0) {
+    static std::array<uint32_t, 256> table;
+    static bool tableReady = false;
+
+    if (!tableReady) {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+
+            table[n] = c;
+        }
+
+        tableReady = true;
+    }
+
+    crc = ~crc;
+
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+static uint32_t Adler32(const std::vector<uint8_t>& data) {
+    uint32_t a = 1;
+    uint32_t b = 0;
+
+    for (auto byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+static void PutBigEndian(std::vector<uint8_t>& data, const uint32_t value) {
+    data.push_back((value >> 24) & 0xFF);
+    data.push_back((value >> 16) & 0xFF);
+    data.push_back((value >> 8) & 0xFF);
+    data.push_back(value & 0xFF);
+}
+
+static void WriteChunk(std::ostream& os, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk(type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+
+    std::vector<uint8_t> header;
+    PutBigEndian(header, static_cast<uint32_t>(data.size()));
+
+    std::vector<uint8_t> crc;
+    PutBigEndian(crc, Crc32(chunk.data(), chunk.size()));
+
+    os.write(reinterpret_cast<const char*>(header.data()), header.size());
+    os.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    os.write(reinterpret_cast<const char*>(crc.data()), crc.size());
+}
+
+static bool WritePng(const std::string& file, const PackedFrame& frame, const uint32_t scale) {
+    std::ofstream os(file, std::ios::binary | std::ios::trunc);
+
+    if (!os.is_open()) {
+        std::cout << "couldn't open file " << file << std::endl;
+        return false;
+    }
+
+    const uint32_t width = VIDEO_MEMORY_COLUMNS * scale;
+    const uint32_t height = VIDEO_MEMORY_ROWS * scale;
+    const size_t rowSize = (width + 7) / 8;
+
+    // Filter type 0 followed by one bit per pixel, most significant bit first.
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        raw.push_back(0);
+        const size_t rowStart = raw.size();
+        raw.resize(rowStart + rowSize, 0);
+
+        for (uint32_t x = 0; x < width; ++x) {
+            const size_t bit = (y / scale) * VIDEO_MEMORY_COLUMNS + (x / scale);
+
+            if (frame[bit / 8] & (0x80 >> (bit % 8))) {
+                raw[rowStart + x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+    }
+
+    std::vector<uint8_t> idat{0x78, 0x01};
+
+    for (size_t offset = 0; offset < raw.size(); offset += 65535) {
+        const size_t blockSize = std::min<size_t>(65535, raw.size() - offset);
+        const bool last = offset + blockSize >= raw.size();
+
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(blockSize & 0xFF);
+        idat.push_back((blockSize >> 8) & 0xFF);
+        idat.push_back(~blockSize & 0xFF);
+        idat.push_back((~blockSize >> 8) & 0xFF);
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+    }
+
+    PutBigEndian(idat, Adler32(raw));
+
+    std::vector<uint8_t> ihdr;
+    PutBigEndian(ihdr, width);
+    PutBigEndian(ihdr, height);
+    // 1-bit depth, indexed color, default compression, filtering and no interlace.
+    ihdr.insert(ihdr.end(), {1, 3, 0, 0, 0});
+
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    os.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    WriteChunk(os, "IHDR", ihdr);
+    WriteChunk(os, "PLTE", std::vector<uint8_t>(PALETTE, PALETTE + sizeof(PALETTE)));
+    WriteChunk(os, "IDAT", idat);
+    WriteChunk(os, "IEND", {});
+
+    return os.good();
+}
+
+bool ExportPngSequence(const std::string& file, const std::string& prefix, const uint32_t scale) {
+    std::ifstream is(file, std::ios::binary);
+
+    if (!is.is_open()) {
+        std::cout << "couldn't open capture file " << file << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    is.read(magic, 4);
+    const int version = is.get();
+    const int columns = is.get();
+    const int rows = is.get();
+
+    if (!is || std::memcmp(magic, CAPTURE_MAGIC, 4) != 0 || version != CAPTURE_VERSION) {
+        std::cout << "not a capture file: " << file << std::endl;
+        return false;
+    }
+
+    if (columns != VIDEO_MEMORY_COLUMNS || rows != VIDEO_MEMORY_ROWS) {
+        std::cout << "unsupported capture resolution: " << columns << "x" << rows << std::endl;
+        return false;
+    }
+
+    PackedFrame frame{{0}};
+    std::array<uint8_t, CAPTURE_FRAME_SIZE * 2> payload;
+    uint32_t frameNumber = 0;
+    uint32_t payloadSize = 0;
+    size_t exported = 0;
+
+    while (ReadLittleEndian(is, frameNumber, 4)) {
+        if (!ReadLittleEndian(is, payloadSize, 2) || payloadSize > payload.size() || payloadSize % 2 != 0) {
+            std::cout << "corrupt capture record for frame " << frameNumber << std::endl;
+            return false;
+        }
+
+        is.read(reinterpret_cast<char*>(payload.data()), payloadSize);
+
+        if (!is) {
+            std::cout << "truncated capture record for frame " << frameNumber << std::endl;
+            return false;
+        }
+
+        size_t offset = 0;
+
+        for (size_t i = 0; i < payloadSize; i += 2) {
+            const uint8_t count = payload[i];
+            const uint8_t value = payload[i + 1];
+
+            if (offset + count > CAPTURE_FRAME_SIZE) {
+                std::cout << "corrupt capture record for frame " << frameNumber << std::endl;
+                return false;
+            }
+
+            for (size_t j = 0; j < count; ++j) {
+                frame[offset++] ^= value;
+            }
+        }
+
+        std::ostringstream name;
+        name << prefix << std::setw(6) << std::setfill('0') << frameNumber << ".png";
+
+        if (!WritePng(name.str(), frame, scale)) {
+            return false;
+        }
+
+        ++exported;
+    }
+
+    std::cout << "exported " << exported << " frames" << std::endl;
+
+    return true;
+}
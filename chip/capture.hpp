@@ -0,0 +1,88 @@
+//
+//  capture.hpp
+//  chip
+//
+//  Created by lex on 19/10/2026.
+//  Copyright © 2026 lex. All rights reserved.
+//
+
+#ifndef capture_hpp
+#define capture_hpp
+
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <string>
+
+#include "chip.hpp"
+
+// Frames waiting for the encoder. 256 frames is a little over four seconds at 60 Hz.
+#define CAPTURE_RING_SIZE 256
+// One bit per pixel.
+#define CAPTURE_FRAME_SIZE (VIDEO_MEMORY_COLUMNS * VIDEO_MEMORY_ROWS / 8)
+#define CAPTURE_MAGIC "CH8V"
+#define CAPTURE_VERSION 1
+
+using PackedFrame = std::array<uint8_t, CAPTURE_FRAME_SIZE>;
+
+// Records video memory to a capture file without a display.
+//
+// The emulation thread only copies the frame into a preallocated ring. A worker thread packs it,
+// XORs it against the previous frame and run-length encodes the result. When the ring is full the
+// frame is dropped instead of waiting for the worker; every record keeps its frame number so drops
+// show up as gaps. TryPushFrame() leaves a frame that doesn't fit to the caller instead.
+// A frame only counts as written once it has been flushed to the file; after a write error the
+// worker discards the rest and Stop() returns false.
+//
+// File layout (all integers little-endian):
+//   "CH8V", version (1 byte), columns (1 byte), rows (1 byte)
+//   repeated: frame number (4 bytes), payload size (2 bytes), payload
+// The payload is a list of (count, byte) pairs which expand to the XOR of the packed frame and
+// the previously recorded one.
+class Capture {
+public:
+    ~Capture();
+    bool Start(const std::string& file);
+    bool PushFrame(const VideoMemory& frame);
+    bool TryPushFrame(const VideoMemory& frame);
+    bool Stop();
+    uint32_t GetWrittenFrames() const;
+    uint32_t GetDroppedFrames() const;
+
+private:
+    struct Slot {
+        uint32_t frame;
+        VideoMemory pixels;
+    };
+
+    // Single producer (emulation thread), single consumer (worker).
+    // Allocated by the first Start(), about half a megabyte.
+    std::unique_ptr<Slot[]> ring;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> failed{false};
+    std::atomic<uint32_t> writtenFrames{0};
+    std::atomic<uint32_t> droppedFrames{0};
+    uint32_t frameCounter = 0;
+
+    std::thread worker;
+    std::ofstream os;
+    PackedFrame previous{{0}};
+
+    void Work();
+    bool Enqueue(const uint32_t frame, const VideoMemory& pixels);
+    void Encode(const Slot& slot);
+    void Flush(uint32_t& pendingFrames);
+};
+
+// Decodes a capture file and writes every recorded frame as <prefix><frame number>.png,
+// each pixel scaled up to a scale × scale block.
+bool ExportPngSequence(const std::string& file, const std::string& prefix, const uint32_t scale);
+
+#endif /* capture_hpp */
@@ -6,6 +6,8 @@
 //  Copyright © 2017 lex. All rights reserved.
 //
 
+#include <algorithm>
+
 #include "chip.hpp"
 
 bool Chip::ReadRom(const std::string& file) {
@@ -40,6 +42,7 @@ void Chip::Initialize() {
     SP = 0;
     delayTimer = 0;
     soundTimer = 0;
+    randomState = static_cast<uint32_t>(std::rand()) | 1;
 
     ClearScreen();
     std::copy_n(FONTSET.begin(), FONTSET_SIZE, memory.begin());
@@ -59,6 +62,51 @@ const VideoMemory& Chip::GetVideoMemory() const {
     return videoMemory;
 }
 
+void Chip::SaveState(ChipState& state) const {
+    state.V = V;
+    state.memory = memory;
+    state.videoMemory = videoMemory;
+    state.stack = stack;
+    state.I = I;
+    state.PC = PC;
+    state.SP = SP;
+    state.delayTimer = delayTimer;
+    state.soundTimer = soundTimer;
+    state.pressedKeys = pressedKeys;
+    state.randomState = randomState;
+}
+
+void Chip::LoadState(const ChipState& state) {
+    V = state.V;
+    memory = state.memory;
+    videoMemory = state.videoMemory;
+    stack = state.stack;
+    I = state.I;
+    PC = state.PC;
+    SP = state.SP;
+    delayTimer = state.delayTimer;
+    soundTimer = state.soundTimer;
+    pressedKeys = state.pressedKeys;
+    randomState = state.randomState;
+}
+
+void Chip::SaveRegisters(ChipRegisters& registers) const {
+    registers.V = V;
+    registers.I = I;
+    registers.PC = PC;
+    registers.SP = SP;
+    registers.delayTimer = delayTimer;
+    registers.soundTimer = soundTimer;
+}
+
+uint8_t Chip::NextRandom() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+
+    return randomState & 0xFF;
+}
+
 void Chip::SetKeyState(const size_t key, const bool pressed) {
     pressedKeys.at(key) = pressed;
 }
@@ -67,7 +115,7 @@ void Chip::DrawSprite(const uint8_t x, const uint8_t y, const uint8_t height) {
     V[F] = 0;
 
     for (int byteIndex = 0; byteIndex < height; ++byteIndex) {
-        const uint8_t byte = memory[I + byteIndex];
+        const uint8_t byte = memory.at(I + byteIndex);
 
         for (int bitIndex = 0; bitIndex < 8; ++bitIndex) {
             const uint8_t bit = (byte >> bitIndex) & 0x1;
@@ -93,7 +141,7 @@ void Chip::DrawSprite(const uint8_t x, const uint8_t y, const uint8_t height) {
 }
 
 void Chip::Step(const uint32_t ticks) {
-    const uint16_t instruction = memory[PC] << 8 | memory[PC + 1];
+    const uint16_t instruction = memory.at(PC) << 8 | memory.at(PC + 1);
 
     // https://en.wikipedia.org/wiki/CHIP-8#Opcode_table
     // NNN: address
@@ -124,7 +172,8 @@ void Chip::Step(const uint32_t ticks) {
 
                 case 0x00EE:
                     // Returns from a subroutine.
-                    PC = stack.at(--SP);
+                    PC = stack.at(SP - 1);
+                    --SP;
                     break;
 
                 default:
@@ -173,7 +222,10 @@ void Chip::Step(const uint32_t ticks) {
             PC += 2;
             break;
 
-        case 0x8000:
+        case 0x8000: {
+            // Flags are written after the result so VF holds the flag when X is F.
+            uint8_t carry = 0;
+
             switch (N) {
                 case 0x0:
                     // Sets VX to the value of VY.
@@ -201,36 +253,41 @@ void Chip::Step(const uint32_t ticks) {
 
                 case 0x4:
                     // Adds VY to VX. VF is set to 1 when there's a carry, and to 0 when there isn't.
-                    V[F] = (static_cast<int>(V[X]) + static_cast<int>(V[Y]) > 255 ? 1 : 0);
+                    carry = (static_cast<int>(V[X]) + static_cast<int>(V[Y]) > 255 ? 1 : 0);
                     V[X] += V[Y];
+                    V[F] = carry;
                     PC += 2;
                     break;
 
                 case 0x5:
                     // VY is subtracted from VX. VF is set to 0 when there's a borrow, and 1 when there isn't.
-                    V[F] = (V[X] > V[Y] ? 1 : 0);
+                    carry = (V[X] >= V[Y] ? 1 : 0);
                     V[X] -= V[Y];
+                    V[F] = carry;
                     PC += 2;
                     break;
 
                 case 0x6:
                     // Shifts VX right by one. VF is set to the value of the least significant bit of VX before the shift.
-                    V[F] = V[X] & 0x1;
+                    carry = V[X] & 0x1;
                     V[X] = V[X] >> 1;
+                    V[F] = carry;
                     PC += 2;
                     break;
 
                 case 0x7:
                     // Sets VX to VY minus VX. VF is set to 0 when there's a borrow, and 1 when there isn't.
-                    V[F] = (V[X] < V[Y] ? 1 : 0);
+                    carry = (V[Y] >= V[X] ? 1 : 0);
                     V[X] = V[Y] - V[X];
+                    V[F] = carry;
                     PC += 2;
                     break;
 
                 case 0xE:
                     // Shifts VX left by one. VF is set to the value of the most significant bit of VX before the shift.
-                    V[F] = (V[X] >> 7) & 0x1;
+                    carry = (V[X] >> 7) & 0x1;
                     V[X] = V[X] << 1;
+                    V[F] = carry;
                     PC += 2;
                     break;
 
@@ -240,6 +297,7 @@ void Chip::Step(const uint32_t ticks) {
             }
 
             break;
+        }
 
         case 0x9000:
             switch (N) {
@@ -268,7 +326,7 @@ void Chip::Step(const uint32_t ticks) {
 
         case 0xC000:
             // Sets VX to the result of a bitwise and operation on a random number (Typically: 0 to 255) and NN.
-            V[X] = (std::rand() % 256) & NN;
+            V[X] = NextRandom() & NN;
             PC += 2;
             break;
 
@@ -417,6 +475,10 @@ void Chip::UnimplementedInstruction(const uint16_t instruction) const {
 }
 
 void Chip::UnknownInstruction(const uint16_t instruction) const {
+    if (!reportUnknownInstructions) {
+        return;
+    }
+
     std::cout << "Unknown instruction: "
               << std::hex << std::uppercase << static_cast<int>(instruction)
               << std::dec << std::nouppercase << std::endl;
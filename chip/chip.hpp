@@ -31,6 +31,31 @@
 using VideoMemory = std::array<std::array<uint8_t, VIDEO_MEMORY_COLUMNS>, VIDEO_MEMORY_ROWS>;
 using PressedKeys = std::array<bool, KEY_COUNT>;
 
+// Everything the guest can observe, for snapshots and restores.
+struct ChipState {
+    std::array<uint8_t, REGISTER_COUNT> V;
+    std::array<uint8_t, MEMORY_SIZE> memory;
+    VideoMemory videoMemory;
+    std::array<uint16_t, STACK_SIZE> stack;
+    uint16_t I;
+    uint16_t PC;
+    uint16_t SP;
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    PressedKeys pressedKeys;
+    uint32_t randomState;
+};
+
+// The part of ChipState that is cheap enough to copy after every instruction.
+struct ChipRegisters {
+    std::array<uint8_t, REGISTER_COUNT> V;
+    uint16_t I;
+    uint16_t PC;
+    uint16_t SP;
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+};
+
 class Chip {
 public:
     bool ReadRom(const std::string& file);
@@ -39,7 +64,11 @@ public:
     void Stop();
     void Resume();
     const VideoMemory& GetVideoMemory() const;
+    void SaveState(ChipState& state) const;
+    void LoadState(const ChipState& state);
+    void SaveRegisters(ChipRegisters& registers) const;
     bool debugging = false;
+    bool reportUnknownInstructions = true;
     void SetKeyState(const size_t key, const bool pressed);
 
 private:
@@ -87,6 +116,11 @@ private:
 
     PressedKeys pressedKeys{false};
 
+    // xorshift32 state for CXNN, kept here instead of std::rand() so runs can be replayed from a snapshot.
+    uint32_t randomState = 1;
+
+    uint8_t NextRandom();
+
     void UnimplementedInstruction(const uint16_t instruction) const;
     void UnknownInstruction(const uint16_t instruction) const;
     void ClearScreen();
@@ -0,0 +1,682 @@
+//
+//  fuzz.cpp
+//  chip
+//
+//  Created by lex on 19/10/2026.
+//  Copyright © 2026 lex. All rights reserved.
+//
+//  Coverage guided fuzzer comparing Chip against ReferenceChip.
+//
+//  Every thread keeps one Chip and one ReferenceChip around for the whole run and restores them
+//  from a generated or mutated ChipState for each input, so there's no process or interpreter setup
+//  per input. Coverage is collected from the reference side: which operation ran at which PC, and
+//  how it went (VF, skip taken, sprite wrapped, fault). Every input that is first to reach a feature
+//  goes into a corpus shared by all threads and stays there, so the corpus never holds more inputs
+//  than there are features.
+//
+//  Registers, PC, SP and timers are compared after every instruction. Memory, the screen and the
+//  stack are too big to copy that often, so they are compared after the last instruction only.
+//
+//  Build: c++ -std=c++11 -O2 -pthread chip/chip.cpp chip/reference.cpp chip/fuzz.cpp -o chip-fuzz
+//  Usage: chip-fuzz [seconds] [threads]
+//         chip-fuzz --replay mismatch-8XY4.state
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "chip.hpp"
+#include "reference.hpp"
+
+// Generated programs live at PROGRAM_START_ADDRESS and jumps mostly stay inside them.
+#define FUZZ_ROM_SIZE 256
+#define FUZZ_CYCLES 1000
+#define FUZZ_OPERATION_COUNT static_cast<size_t>(Operation::Count)
+#define FUZZ_OUTCOME_COUNT 8
+#define FUZZ_FAULT_OUTCOME (FUZZ_OUTCOME_COUNT - 1)
+#define FUZZ_FEATURE_COUNT (FUZZ_OPERATION_COUNT * MEMORY_SIZE + FUZZ_OPERATION_COUNT * FUZZ_OUTCOME_COUNT)
+// Reproducer files hold the raw ChipState, so they only replay with a build of the same layout.
+#define FUZZ_STATE_MAGIC "CH8S"
+
+using Random = std::mt19937;
+
+// What the fuzzer varies. Everything else in the starting ChipState is what Chip::Initialize()
+// leaves behind, so corpus entries stay a few hundred bytes instead of a whole ChipState.
+struct FuzzInput {
+    std::array<uint8_t, FUZZ_ROM_SIZE> program;
+    std::array<uint8_t, REGISTER_COUNT> V;
+    std::array<uint16_t, STACK_SIZE> stack;
+    uint16_t I;
+    uint16_t PC;
+    uint16_t SP;
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    PressedKeys pressedKeys;
+    uint32_t randomState;
+};
+
+struct Shared {
+    ChipState base;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> coverage{new std::atomic<uint8_t>[FUZZ_FEATURE_COUNT]()};
+    std::atomic<size_t> features{0};
+
+    std::mutex corpusMutex;
+    std::vector<FuzzInput> corpus;
+
+    std::mutex reportMutex;
+    std::set<Operation> reported;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> executions{0};
+    std::atomic<uint32_t> mismatches{0};
+};
+
+static uint8_t InterestingByte(Random& random) {
+    static const uint8_t VALUES[] = {0x00, 0x01, 0x0F, 0x10, 0x3F, 0x40, 0x7F, 0x80, 0xFE, 0xFF};
+
+    if (random() % 2) {
+        return VALUES[random() % sizeof(VALUES)];
+    }
+
+    return random() & 0xFF;
+}
+
+static uint16_t InterestingIndex(Random& random) {
+    switch (random() % 4) {
+        case 0:
+            return MEMORY_SIZE - 1 - random() % 16;
+        case 1:
+            return 0xFFFF - random() % 16;
+        default:
+            return random() % MEMORY_SIZE;
+    }
+}
+
+static uint16_t ProgramAddress(Random& random) {
+    if (random() % 8 == 0) {
+        return random() & 0xFFF;
+    }
+
+    return PROGRAM_START_ADDRESS + (random() % FUZZ_ROM_SIZE & ~1);
+}
+
+static uint16_t GenerateInstruction(Random& random) {
+    const uint16_t x = (random() & 0xF) << 8;
+    const uint16_t y = (random() & 0xF) << 4;
+    const uint16_t nn = InterestingByte(random);
+
+    switch (random() % 24) {
+        case 0:
+            return random() % 2 ? 0x00E0 : 0x00EE;
+
+        case 1:
+            return 0x1000 | ProgramAddress(random);
+
+        case 2:
+            return 0x2000 | ProgramAddress(random);
+
+        case 3:
+            return 0x3000 | x | nn;
+
+        case 4:
+            return 0x4000 | x | nn;
+
+        case 5:
+            return 0x5000 | x | y;
+
+        case 6:
+            return 0x6000 | x | nn;
+
+        case 7:
+            return 0x7000 | x | nn;
+
+        case 8:
+        case 9:
+        case 10: {
+            static const uint8_t ALU[] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE};
+            return 0x8000 | x | y | ALU[random() % sizeof(ALU)];
+        }
+
+        case 11:
+            return 0x9000 | x | y;
+
+        case 12:
+            return 0xA000 | (InterestingIndex(random) & 0xFFF);
+
+        case 13:
+            return 0xB000 | ProgramAddress(random);
+
+        case 14:
+            return 0xC000 | x | nn;
+
+        case 15:
+        case 16:
+            return 0xD000 | x | y | (random() & 0xF);
+
+        case 17:
+            return 0xE000 | x | (random() % 2 ? 0x9E : 0xA1);
+
+        case 18:
+        case 19:
+        case 20: {
+            static const uint8_t MISC[] = {0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x33, 0x55, 0x65};
+            return 0xF000 | x | MISC[random() % sizeof(MISC)];
+        }
+
+        default:
+            return random() & 0xFFFF;
+    }
+}
+
+static void PutInstruction(FuzzInput& input, const size_t slot, const uint16_t instruction) {
+    input.program[slot * 2] = instruction >> 8;
+    input.program[slot * 2 + 1] = instruction & 0xFF;
+}
+
+static void Generate(Random& random, FuzzInput& input) {
+    for (size_t slot = 0; slot < FUZZ_ROM_SIZE / 2; ++slot) {
+        PutInstruction(input, slot, GenerateInstruction(random));
+    }
+
+    for (auto& v : input.V) {
+        v = InterestingByte(random);
+    }
+
+    for (auto& address : input.stack) {
+        address = ProgramAddress(random);
+    }
+
+    for (auto& key : input.pressedKeys) {
+        key = random() % 4 == 0;
+    }
+
+    input.I = InterestingIndex(random);
+    input.PC = random() % 16 == 0 ? ProgramAddress(random) : PROGRAM_START_ADDRESS;
+    input.SP = random() % (STACK_SIZE + 1);
+    input.delayTimer = InterestingByte(random);
+    input.soundTimer = InterestingByte(random);
+    // xorshift never leaves 0
+    input.randomState = random() | 1;
+}
+
+static void Mutate(Random& random, FuzzInput& input) {
+    const size_t count = 1 + random() % 4;
+
+    for (size_t i = 0; i < count; ++i) {
+        switch (random() % 8) {
+            case 0:
+            case 1:
+            case 2:
+                PutInstruction(input, random() % (FUZZ_ROM_SIZE / 2), GenerateInstruction(random));
+                break;
+
+            case 3:
+                input.program[random() % FUZZ_ROM_SIZE] ^= 1 << (random() % 8);
+                break;
+
+            case 4:
+                input.V[random() % REGISTER_COUNT] = InterestingByte(random);
+                break;
+
+            case 5:
+                input.I = InterestingIndex(random);
+                break;
+
+            case 6:
+                input.SP = random() % (STACK_SIZE + 1);
+                break;
+
+            default: {
+                const size_t key = random() % KEY_COUNT;
+                input.pressedKeys[key] = !input.pressedKeys[key];
+                break;
+            }
+        }
+    }
+}
+
+static void Expand(const ChipState& base, const FuzzInput& input, ChipState& state) {
+    state = base;
+    std::copy(input.program.begin(), input.program.end(), state.memory.begin() + PROGRAM_START_ADDRESS);
+    state.V = input.V;
+    state.stack = input.stack;
+    state.I = input.I;
+    state.PC = input.PC;
+    state.SP = input.SP;
+    state.delayTimer = input.delayTimer;
+    state.soundTimer = input.soundTimer;
+    state.pressedKeys = input.pressedKeys;
+    state.randomState = input.randomState;
+}
+
+static bool SameRegisters(const ChipRegisters& chip, const ChipState& reference) {
+    return chip.V == reference.V
+        && chip.I == reference.I
+        && chip.PC == reference.PC
+        && chip.SP == reference.SP
+        && chip.delayTimer == reference.delayTimer
+        && chip.soundTimer == reference.soundTimer;
+}
+
+static bool SameState(const ChipState& a, const ChipState& b, std::string& difference) {
+    std::ostringstream os;
+    os << std::hex << std::uppercase;
+
+    for (size_t i = 0; i < REGISTER_COUNT; ++i) {
+        if (a.V[i] != b.V[i]) {
+            os << " V" << i << " " << static_cast<int>(a.V[i]) << " != " << static_cast<int>(b.V[i]);
+        }
+    }
+
+    if (a.memory != b.memory) {
+        os << " memory";
+    }
+
+    if (a.videoMemory != b.videoMemory) {
+        os << " videoMemory";
+    }
+
+    if (a.stack != b.stack) {
+        os << " stack";
+    }
+
+    if (a.I != b.I) {
+        os << " I " << a.I << " != " << b.I;
+    }
+
+    if (a.PC != b.PC) {
+        os << " PC " << a.PC << " != " << b.PC;
+    }
+
+    if (a.SP != b.SP) {
+        os << " SP " << a.SP << " != " << b.SP;
+    }
+
+    if (a.delayTimer != b.delayTimer) {
+        os << " delayTimer";
+    }
+
+    if (a.soundTimer != b.soundTimer) {
+        os << " soundTimer";
+    }
+
+    if (a.pressedKeys != b.pressedKeys) {
+        os << " pressedKeys";
+    }
+
+    if (a.randomState != b.randomState) {
+        os << " randomState";
+    }
+
+    difference = os.str();
+
+    return difference.empty();
+}
+
+static bool SaveStateFile(const std::string& file, const ChipState& state) {
+    std::ofstream os(file, std::ios::binary | std::ios::trunc);
+
+    if (!os.is_open()) {
+        std::cout << "couldn't open file " << file << std::endl;
+        return false;
+    }
+
+    const uint32_t size = sizeof(ChipState);
+    os.write(FUZZ_STATE_MAGIC, 4);
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    os.write(reinterpret_cast<const char*>(&state), sizeof(ChipState));
+
+    return os.good();
+}
+
+static bool LoadStateFile(const std::string& file, ChipState& state) {
+    std::ifstream is(file, std::ios::binary);
+
+    if (!is.is_open()) {
+        std::cout << "couldn't open file " << file << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t size = 0;
+    is.read(magic, 4);
+    is.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+    if (!is || std::string(magic, 4) != FUZZ_STATE_MAGIC || size != sizeof(ChipState)) {
+        std::cout << "not a state file from this build: " << file << std::endl;
+        return false;
+    }
+
+    is.read(reinterpret_cast<char*>(&state), sizeof(ChipState));
+
+    if (!is) {
+        std::cout << "truncated state file: " << file << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+struct Divergence {
+    uint32_t cycle = 0;
+    uint16_t pc = 0;
+    uint16_t instruction = 0;
+    Operation operation = Operation::Unknown;
+    // Empty if both interpreters agreed until the end or until they faulted together.
+    std::string difference;
+};
+
+// Runs both interpreters from input one step at a time, comparing the whole state after every step.
+// With trace set every step is printed.
+static Divergence FindDivergence(Chip& chip, ReferenceChip& reference, const ChipState& input, const bool trace) {
+    Divergence divergence;
+    ChipState result;
+
+    chip.LoadState(input);
+    reference.state = input;
+
+    for (; divergence.cycle < FUZZ_CYCLES; ++divergence.cycle) {
+        const uint32_t ticks = divergence.cycle * 2;
+        const ChipState& state = reference.state;
+
+        divergence.pc = state.PC;
+        divergence.instruction = state.PC + 1 < MEMORY_SIZE ? state.memory[state.PC] << 8 | state.memory[state.PC + 1] : 0;
+
+        bool chipFaulted = false;
+
+        try {
+            chip.Step(ticks);
+        } catch (const std::out_of_range&) {
+            chipFaulted = true;
+        }
+
+        const bool referenceFaulted = !reference.Step(ticks);
+        divergence.operation = reference.lastOperation;
+
+        if (trace) {
+            std::cout << std::setw(4) << divergence.cycle
+                      << std::hex << std::uppercase
+                      << "  PC " << std::setw(3) << divergence.pc
+                      << "  " << std::setw(4) << std::setfill('0') << divergence.instruction << std::setfill(' ')
+                      << std::dec << std::nouppercase
+                      << "  " << OperationName(divergence.operation)
+                      << (referenceFaulted ? "  fault" : "") << std::endl;
+        }
+
+        if (chipFaulted != referenceFaulted) {
+            divergence.difference = chipFaulted ? " Chip faulted, reference didn't" : " reference faulted, Chip didn't";
+            break;
+        }
+
+        if (chipFaulted) {
+            break;
+        }
+
+        chip.SaveState(result);
+
+        if (!SameState(result, reference.state, divergence.difference)) {
+            break;
+        }
+    }
+
+    return divergence;
+}
+
+static void PrintDivergence(const Divergence& divergence) {
+    std::cout << "mismatch on " << OperationName(divergence.operation)
+              << std::hex << std::uppercase
+              << " (" << divergence.instruction << ") at PC " << divergence.pc
+              << std::dec << std::nouppercase
+              << " after " << divergence.cycle << " cycles:" << divergence.difference << std::endl;
+}
+
+static bool Record(Shared& shared, const size_t feature) {
+    std::atomic<uint8_t>& seen = shared.coverage[feature];
+
+    if (seen.load(std::memory_order_relaxed) || seen.exchange(1)) {
+        return false;
+    }
+
+    ++shared.features;
+
+    return true;
+}
+
+class Worker {
+public:
+    Worker(Shared& shared, const uint32_t seed) : shared(shared), random(seed) {
+        chip.reportUnknownInstructions = false;
+    }
+
+    void Run() {
+        while (!shared.stopping) {
+            if (!PickInput()) {
+                Generate(random, input);
+            }
+
+            Expand(shared.base, input, start);
+            Execute();
+            ++shared.executions;
+        }
+    }
+
+private:
+    Shared& shared;
+    Random random;
+    Chip chip;
+    ReferenceChip reference;
+    FuzzInput input;
+    ChipState start;
+    ChipState result;
+    ChipRegisters registers;
+
+    bool PickInput() {
+        if (random() % 8 == 0) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(shared.corpusMutex);
+
+            if (shared.corpus.empty()) {
+                return false;
+            }
+
+            input = shared.corpus[random() % shared.corpus.size()];
+        }
+
+        Mutate(random, input);
+
+        return true;
+    }
+
+    // Runs both interpreters from the start state for up to cycles steps, stopping at the first
+    // fault or the first step after which the registers differ. Returns the number of steps that
+    // completed on both sides; chipFaulted/referenceFaulted tell whether the step after that faulted.
+    uint32_t RunBoth(const uint32_t cycles, bool& chipFaulted, bool& referenceFaulted, bool& registersDiffer, bool& newCoverage) {
+        chip.LoadState(start);
+        reference.state = start;
+        chipFaulted = false;
+        referenceFaulted = false;
+        registersDiffer = false;
+
+        for (uint32_t cycle = 0; cycle < cycles; ++cycle) {
+            const uint32_t ticks = cycle * 2;
+            const uint16_t pc = reference.state.PC;
+
+            try {
+                chip.Step(ticks);
+            } catch (const std::out_of_range&) {
+                chipFaulted = true;
+            }
+
+            referenceFaulted = !reference.Step(ticks);
+
+            const size_t operation = static_cast<size_t>(reference.lastOperation);
+            const size_t outcome = referenceFaulted ? FUZZ_FAULT_OUTCOME : reference.lastOutcome;
+
+            newCoverage |= Record(shared, operation * MEMORY_SIZE + (pc % MEMORY_SIZE));
+            newCoverage |= Record(shared, FUZZ_OPERATION_COUNT * MEMORY_SIZE + operation * FUZZ_OUTCOME_COUNT + outcome);
+
+            if (chipFaulted || referenceFaulted) {
+                return cycle;
+            }
+
+            chip.SaveRegisters(registers);
+
+            if (!SameRegisters(registers, reference.state)) {
+                registersDiffer = true;
+                return cycle + 1;
+            }
+        }
+
+        return cycles;
+    }
+
+    void Execute() {
+        bool chipFaulted = false;
+        bool referenceFaulted = false;
+        bool registersDiffer = false;
+        bool newCoverage = false;
+        bool mismatch = false;
+
+        const uint32_t completed = RunBoth(FUZZ_CYCLES, chipFaulted, referenceFaulted, registersDiffer, newCoverage);
+
+        if (registersDiffer || chipFaulted != referenceFaulted) {
+            mismatch = true;
+        } else {
+            if (chipFaulted) {
+                // What a faulting instruction leaves behind isn't specified, so compare the state
+                // right before it instead.
+                bool ignored = false;
+                RunBoth(completed, chipFaulted, referenceFaulted, registersDiffer, ignored);
+            }
+
+            std::string difference;
+            chip.SaveState(result);
+            mismatch = !SameState(result, reference.state, difference);
+        }
+
+        if (mismatch) {
+            Report();
+        } else if (newCoverage) {
+            // Only the input that first reached a feature gets here, so nothing is ever evicted.
+            std::lock_guard<std::mutex> lock(shared.corpusMutex);
+            shared.corpus.push_back(input);
+        }
+    }
+
+    void Report() {
+        ++shared.mismatches;
+
+        const Divergence divergence = FindDivergence(chip, reference, start, false);
+
+        std::lock_guard<std::mutex> lock(shared.reportMutex);
+
+        // One report per operation, the rest are most likely the same bug.
+        if (!shared.reported.insert(divergence.operation).second) {
+            return;
+        }
+
+        const std::string file = std::string("mismatch-") + OperationName(divergence.operation) + ".state";
+
+        PrintDivergence(divergence);
+
+        if (SaveStateFile(file, start)) {
+            std::cout << "  replay with: chip-fuzz --replay " << file << std::endl;
+        }
+    }
+};
+
+// Single-steps a saved input on both interpreters and prints every instruction up to the mismatch.
+int Replay(const std::string& file) {
+    ChipState input;
+
+    if (!LoadStateFile(file, input)) {
+        return 1;
+    }
+
+    Chip chip;
+    chip.reportUnknownInstructions = false;
+    ReferenceChip reference;
+
+    const Divergence divergence = FindDivergence(chip, reference, input, true);
+
+    if (divergence.difference.empty()) {
+        std::cout << "no mismatch" << std::endl;
+        return 0;
+    }
+
+    PrintDivergence(divergence);
+
+    return 1;
+}
+
+int main(int argc, const char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--replay") {
+        return Replay(argv[2]);
+    }
+
+    const uint32_t seconds = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 10;
+    uint32_t threadCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : std::thread::hardware_concurrency();
+
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    Shared shared;
+
+    Chip chip;
+    chip.Initialize();
+    chip.SaveState(shared.base);
+
+    std::cout << "fuzzing for " << seconds << " seconds on " << threadCount << " threads" << std::endl;
+
+    const uint32_t seed = std::random_device()();
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(new Worker(shared, seed + i));
+        threads.emplace_back(&Worker::Run, workers.back().get());
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t elapsed = 1; elapsed <= seconds; ++elapsed) {
+        std::this_thread::sleep_until(start + std::chrono::seconds(elapsed));
+
+        size_t corpusSize = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(shared.corpusMutex);
+            corpusSize = shared.corpus.size();
+        }
+
+        std::cout << elapsed << "s: " << shared.executions << " executions, "
+                  << shared.features << " features, "
+                  << corpusSize << " in corpus, "
+                  << shared.mismatches << " mismatches" << std::endl;
+    }
+
+    shared.stopping = true;
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    return shared.mismatches == 0 ? 0 : 1;
+}
@@ -8,12 +8,15 @@
 
 #include <iostream>
 #include <algorithm>
+#include <stdexcept>
 #include <SDL.h>
 
 #include "chip.hpp"
+#include "capture.hpp"
 
 #define WINDOW_WIDTH 1280
 #define WINDOW_HEIGHT 640
+#define EXPORT_SCALE 10
 
 size_t mapKey(SDL_Keycode keycode) {
     switch (keycode) {
@@ -54,13 +57,121 @@ size_t mapKey(SDL_Keycode keycode) {
     }
 }
 
+// Steps the chip, returning false if the rom touched memory, the stack or a key out of range.
+bool stepChip(Chip& chip, const uint32_t ticks) {
+    try {
+        chip.Step(ticks);
+    } catch (const std::out_of_range&) {
+        ChipState state;
+        chip.SaveState(state);
+
+        const int instruction = state.PC + 1 < MEMORY_SIZE ? state.memory[state.PC] << 8 | state.memory[state.PC + 1] : 0;
+
+        std::cout << "Fault at PC: "
+                  << std::hex << std::uppercase << static_cast<int>(state.PC)
+                  << " Instruction: " << instruction
+                  << std::dec << std::nouppercase << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+// Runs without a window at full speed, pretending each cycle takes 2 ms like the 500 Hz SDL loop.
+// There is no frame deadline here, so wait for the encoder instead of dropping frames.
+bool runHeadless(Chip& chip, Capture& capture, const bool capturing, const uint32_t cycles) {
+    for (uint32_t cycle = 0; cycle < cycles; ++cycle) {
+        const uint32_t ticks = cycle * 2;
+
+        if (!stepChip(chip, ticks)) {
+            return false;
+        }
+
+        if (capturing && ticks % 16 == 0) {
+            while (!capture.TryPushFrame(chip.GetVideoMemory())) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    return true;
+}
+
+void printUsage() {
+    std::cout << "usage: chip rom [--capture file] [--headless cycles]" << std::endl;
+    std::cout << "       chip --export capture prefix" << std::endl;
+}
+
 int main(int argc, const char* argv[]) {
+    if (argc == 4 && std::string(argv[1]) == "--export") {
+        return ExportPngSequence(argv[2], argv[3], EXPORT_SCALE) ? 0 : 1;
+    }
+
     if (argc < 2) {
-        std::cout << "need rom" << std::endl;
+        printUsage();
         return 1;
     }
 
     const std::string file = argv[1];
+    std::string captureFile;
+    uint32_t headlessCycles = 0;
+
+    for (int i = 2; i < argc; i += 2) {
+        const std::string option = argv[i];
+
+        if (i + 1 >= argc) {
+            std::cout << "missing value for " << option << std::endl;
+            printUsage();
+            return 1;
+        }
+
+        const std::string value = argv[i + 1];
+
+        if (option == "--capture" && !value.empty()) {
+            captureFile = value;
+        } else if (option == "--headless") {
+            char* end = nullptr;
+            const unsigned long cycles = std::strtoul(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || value[0] == '-' || cycles == 0 || cycles > UINT32_MAX) {
+                std::cout << "invalid cycle count " << value << std::endl;
+                printUsage();
+                return 1;
+            }
+
+            headlessCycles = static_cast<uint32_t>(cycles);
+        } else {
+            std::cout << "unknown option " << option << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    Chip chip;
+
+    if (!chip.ReadRom(file)) {
+        return 1;
+    }
+
+    chip.Initialize();
+
+    Capture capture;
+
+    if (!captureFile.empty() && !capture.Start(captureFile)) {
+        return 1;
+    }
+
+    if (headlessCycles > 0) {
+        const bool completed = runHeadless(chip, capture, !captureFile.empty(), headlessCycles);
+        const bool captured = capture.Stop();
+
+        if (!captureFile.empty()) {
+            std::cout << "captured " << capture.GetWrittenFrames() << " frames, dropped " << capture.GetDroppedFrames() << std::endl;
+        }
+
+        return completed && captured ? 0 : 1;
+    }
 
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
@@ -77,21 +188,14 @@ int main(int argc, const char* argv[]) {
         return 1;
     }
 
-
-    Chip chip;
-
-    if (!chip.ReadRom(file)) {
-        return 1;
-    }
-
-    chip.Initialize();
-
     const uint32_t targetMilliseconds = static_cast<uint32_t>(1.0f / 500.0f * 1000.0f);
 
     SDL_Event event;
     SDL_Texture* texture;
     texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
     bool running = true;
+    bool faulted = false;
+    uint32_t lastCaptureTick = 0;
 
     while (running) {
         const uint32_t startTicks = SDL_GetTicks();
@@ -115,7 +219,10 @@ int main(int argc, const char* argv[]) {
                 switch (event.key.keysym.sym) {
                     case SDLK_RETURN:
                         // fix this, timers will break
-                        chip.Step(startTicks);
+                        if (!stepChip(chip, startTicks)) {
+                            faulted = true;
+                        }
+
                         break;
 
                     case SDLK_ESCAPE:
@@ -138,8 +245,18 @@ int main(int argc, const char* argv[]) {
             }
         }
 
-        if (!chip.debugging) {
-            chip.Step(startTicks);
+        if (!faulted && !chip.debugging && !stepChip(chip, startTicks)) {
+            faulted = true;
+        }
+
+        if (faulted) {
+            running = false;
+        }
+
+        // one capture frame per timer tick
+        if (startTicks / 16 != lastCaptureTick) {
+            capture.PushFrame(chip.GetVideoMemory());
+            lastCaptureTick = startTicks / 16;
         }
 
         // draw the screen
@@ -170,9 +287,15 @@ int main(int argc, const char* argv[]) {
         SDL_Delay(targetMilliseconds - dt);
     }
 
+    const bool captured = capture.Stop();
+
+    if (!captureFile.empty()) {
+        std::cout << "captured " << capture.GetWrittenFrames() << " frames, dropped " << capture.GetDroppedFrames() << std::endl;
+    }
+
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 
-    return 0;
+    return faulted || !captured ? 1 : 0;
 }
@@ -0,0 +1,443 @@
+//
+//  reference.cpp
+//  chip
+//
+//  Created by lex on 19/10/2026.
+//  Copyright © 2026 lex. All rights reserved.
+//
+
+#include "reference.hpp"
+
+const char* OperationName(const Operation operation) {
+    static const char* const NAMES[] = {
+        "00E0", "00EE", "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN",
+        "8XY0", "8XY1", "8XY2", "8XY3", "8XY4", "8XY5", "8XY6", "8XY7", "8XYE", "9XY0",
+        "ANNN", "BNNN", "CXNN", "DXYN", "EX9E", "EXA1",
+        "FX07", "FX0A", "FX15", "FX18", "FX1E", "FX29", "FX33", "FX55", "FX65",
+        "unknown"
+    };
+
+    return NAMES[static_cast<size_t>(operation)];
+}
+
+static Operation Decode(const uint16_t instruction) {
+    const uint8_t n = instruction & 0xF;
+    const uint8_t nn = instruction & 0xFF;
+
+    switch (instruction >> 12) {
+        case 0x0:
+            // only the low byte is looked at, like Chip does
+            switch (nn) {
+                case 0xE0:
+                    return Operation::ClearScreen;
+
+                case 0xEE:
+                    return Operation::Return;
+
+                default:
+                    return Operation::Unknown;
+            }
+
+        case 0x1:
+            return Operation::Jump;
+
+        case 0x2:
+            return Operation::Call;
+
+        case 0x3:
+            return Operation::SkipIfEqualImmediate;
+
+        case 0x4:
+            return Operation::SkipIfNotEqualImmediate;
+
+        case 0x5:
+            return Operation::SkipIfEqual;
+
+        case 0x6:
+            return Operation::SetImmediate;
+
+        case 0x7:
+            return Operation::AddImmediate;
+
+        case 0x8:
+            switch (n) {
+                case 0x0:
+                    return Operation::Set;
+
+                case 0x1:
+                    return Operation::Or;
+
+                case 0x2:
+                    return Operation::And;
+
+                case 0x3:
+                    return Operation::Xor;
+
+                case 0x4:
+                    return Operation::Add;
+
+                case 0x5:
+                    return Operation::Subtract;
+
+                case 0x6:
+                    return Operation::ShiftRight;
+
+                case 0x7:
+                    return Operation::SubtractReverse;
+
+                case 0xE:
+                    return Operation::ShiftLeft;
+
+                default:
+                    return Operation::Unknown;
+            }
+
+        case 0x9:
+            return n == 0 ? Operation::SkipIfNotEqual : Operation::Unknown;
+
+        case 0xA:
+            return Operation::SetIndex;
+
+        case 0xB:
+            return Operation::JumpOffset;
+
+        case 0xC:
+            return Operation::Random;
+
+        case 0xD:
+            return Operation::Draw;
+
+        case 0xE:
+            switch (nn) {
+                case 0x9E:
+                    return Operation::SkipIfKey;
+
+                case 0xA1:
+                    return Operation::SkipIfNotKey;
+
+                default:
+                    return Operation::Unknown;
+            }
+
+        default:
+            switch (nn) {
+                case 0x07:
+                    return Operation::GetDelayTimer;
+
+                case 0x0A:
+                    return Operation::WaitForKey;
+
+                case 0x15:
+                    return Operation::SetDelayTimer;
+
+                case 0x18:
+                    return Operation::SetSoundTimer;
+
+                case 0x1E:
+                    return Operation::AddIndex;
+
+                case 0x29:
+                    return Operation::SetIndexToCharacter;
+
+                case 0x33:
+                    return Operation::StoreDecimal;
+
+                case 0x55:
+                    return Operation::StoreRegisters;
+
+                case 0x65:
+                    return Operation::LoadRegisters;
+
+                default:
+                    return Operation::Unknown;
+            }
+    }
+}
+
+bool ReferenceChip::Draw(const uint8_t x, const uint8_t y, const uint8_t height) {
+    ChipState& s = state;
+
+    for (size_t row = 0; row < height; ++row) {
+        if (s.I + row >= MEMORY_SIZE) {
+            return false;
+        }
+    }
+
+    bool collision = false;
+
+    for (size_t row = 0; row < height; ++row) {
+        const uint8_t sprite = s.memory[s.I + row];
+
+        for (size_t column = 0; column < 8; ++column) {
+            if (!(sprite & (0x80 >> column))) {
+                continue;
+            }
+
+            uint8_t& pixel = s.videoMemory[(y + row) % VIDEO_MEMORY_ROWS][(x + column) % VIDEO_MEMORY_COLUMNS];
+
+            if (pixel) {
+                collision = true;
+            }
+
+            pixel ^= 1;
+        }
+    }
+
+    s.V[F] = collision ? 1 : 0;
+
+    const bool wrapped = height > 0 && (x + 7 >= VIDEO_MEMORY_COLUMNS || y + height - 1 >= VIDEO_MEMORY_ROWS);
+    lastOutcome = (collision ? 1 : 0) | (wrapped ? 2 : 0);
+
+    return true;
+}
+
+bool ReferenceChip::Step(const uint32_t ticks) {
+    ChipState& s = state;
+
+    if (s.PC + 1 >= MEMORY_SIZE) {
+        lastOperation = Operation::Unknown;
+        return false;
+    }
+
+    const uint16_t instruction = s.memory[s.PC] << 8 | s.memory[s.PC + 1];
+    const uint16_t nnn = instruction & 0xFFF;
+    const uint8_t nn = instruction & 0xFF;
+    const uint8_t n = instruction & 0xF;
+    const uint8_t x = (instruction >> 8) & 0xF;
+    const uint8_t y = (instruction >> 4) & 0xF;
+
+    uint8_t& vx = s.V[x];
+    const uint8_t vy = s.V[y];
+    uint16_t next = s.PC + 2;
+
+    lastOperation = Decode(instruction);
+    lastOutcome = 0;
+
+    switch (lastOperation) {
+        case Operation::ClearScreen:
+            for (auto& row : s.videoMemory) {
+                row.fill(0);
+            }
+
+            break;
+
+        case Operation::Return:
+            if (s.SP == 0 || s.SP > STACK_SIZE) {
+                return false;
+            }
+
+            --s.SP;
+            next = s.stack[s.SP];
+            break;
+
+        case Operation::Call:
+            if (s.SP >= STACK_SIZE) {
+                return false;
+            }
+
+            s.stack[s.SP] = next;
+            ++s.SP;
+            next = nnn;
+            break;
+
+        case Operation::Jump:
+            next = nnn;
+            break;
+
+        case Operation::JumpOffset:
+            next = nnn + s.V[0];
+            break;
+
+        case Operation::SkipIfEqualImmediate:
+            lastOutcome = vx == nn;
+            break;
+
+        case Operation::SkipIfNotEqualImmediate:
+            lastOutcome = vx != nn;
+            break;
+
+        case Operation::SkipIfEqual:
+            lastOutcome = vx == vy;
+            break;
+
+        case Operation::SkipIfNotEqual:
+            lastOutcome = vx != vy;
+            break;
+
+        case Operation::SetImmediate:
+            vx = nn;
+            break;
+
+        case Operation::AddImmediate:
+            vx = static_cast<uint8_t>(vx + nn);
+            break;
+
+        case Operation::Set:
+            vx = vy;
+            break;
+
+        case Operation::Or:
+            vx |= vy;
+            break;
+
+        case Operation::And:
+            vx &= vy;
+            break;
+
+        case Operation::Xor:
+            vx ^= vy;
+            break;
+
+        case Operation::Add: {
+            const unsigned sum = vx + vy;
+            vx = sum & 0xFF;
+            s.V[F] = lastOutcome = sum > 0xFF;
+            break;
+        }
+
+        case Operation::Subtract: {
+            const bool noBorrow = vx >= vy;
+            vx = static_cast<uint8_t>(vx - vy);
+            s.V[F] = lastOutcome = noBorrow;
+            break;
+        }
+
+        case Operation::SubtractReverse: {
+            const bool noBorrow = vy >= vx;
+            vx = static_cast<uint8_t>(vy - vx);
+            s.V[F] = lastOutcome = noBorrow;
+            break;
+        }
+
+        case Operation::ShiftRight: {
+            const uint8_t lowest = vx & 1;
+            vx >>= 1;
+            s.V[F] = lastOutcome = lowest;
+            break;
+        }
+
+        case Operation::ShiftLeft: {
+            const uint8_t highest = vx >> 7;
+            vx = static_cast<uint8_t>(vx << 1);
+            s.V[F] = lastOutcome = highest;
+            break;
+        }
+
+        case Operation::SetIndex:
+            s.I = nnn;
+            break;
+
+        case Operation::Random:
+            s.randomState ^= s.randomState << 13;
+            s.randomState ^= s.randomState >> 17;
+            s.randomState ^= s.randomState << 5;
+            vx = s.randomState & nn;
+            break;
+
+        case Operation::Draw:
+            if (!Draw(vx, vy, n)) {
+                return false;
+            }
+
+            break;
+
+        case Operation::SkipIfKey:
+        case Operation::SkipIfNotKey:
+            if (vx >= KEY_COUNT) {
+                return false;
+            }
+
+            lastOutcome = s.pressedKeys[vx] == (lastOperation == Operation::SkipIfKey);
+            break;
+
+        case Operation::GetDelayTimer:
+            vx = s.delayTimer;
+            break;
+
+        case Operation::SetDelayTimer:
+            s.delayTimer = vx;
+            break;
+
+        case Operation::SetSoundTimer:
+            s.soundTimer = vx;
+            break;
+
+        case Operation::WaitForKey:
+            next = s.PC;
+
+            for (uint8_t key = 0; key < KEY_COUNT; ++key) {
+                if (s.pressedKeys[key]) {
+                    vx = key;
+                    next = s.PC + 2;
+                    lastOutcome = 1;
+                    break;
+                }
+            }
+
+            break;
+
+        case Operation::AddIndex:
+            s.I = static_cast<uint16_t>(s.I + vx);
+            break;
+
+        case Operation::SetIndexToCharacter:
+            s.I = FONTSET_CHARACTER_SIZE * vx;
+            break;
+
+        case Operation::StoreDecimal:
+            if (s.I + 2 >= MEMORY_SIZE) {
+                return false;
+            }
+
+            s.memory[s.I] = vx / 100;
+            s.memory[s.I + 1] = (vx / 10) % 10;
+            s.memory[s.I + 2] = vx % 10;
+            break;
+
+        case Operation::StoreRegisters:
+        case Operation::LoadRegisters:
+            if (s.I + x >= MEMORY_SIZE) {
+                return false;
+            }
+
+            for (size_t i = 0; i <= x; ++i) {
+                if (lastOperation == Operation::StoreRegisters) {
+                    s.memory[s.I + i] = s.V[i];
+                } else {
+                    s.V[i] = s.memory[s.I + i];
+                }
+            }
+
+            s.I = static_cast<uint16_t>(s.I + x + 1);
+            lastOutcome = x == F;
+            break;
+
+        case Operation::Unknown:
+        case Operation::Count:
+            next = s.PC;
+            break;
+    }
+
+    if (lastOutcome && (lastOperation == Operation::SkipIfEqualImmediate
+                        || lastOperation == Operation::SkipIfNotEqualImmediate
+                        || lastOperation == Operation::SkipIfEqual
+                        || lastOperation == Operation::SkipIfNotEqual
+                        || lastOperation == Operation::SkipIfKey
+                        || lastOperation == Operation::SkipIfNotKey)) {
+        next += 2;
+    }
+
+    s.PC = next;
+
+    if (ticks % 16 == 0) {
+        if (s.delayTimer > 0) {
+            --s.delayTimer;
+        }
+
+        if (s.soundTimer > 0) {
+            --s.soundTimer;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+//
+//  reference.hpp
+//  chip
+//
+//  Created by lex on 19/10/2026.
+//  Copyright © 2026 lex. All rights reserved.
+//
+
+#ifndef reference_hpp
+#define reference_hpp
+
+#include <cstdint>
+
+#include "chip.hpp"
+
+// Every instruction the interpreter knows, plus one for everything it doesn't.
+enum class Operation : uint8_t {
+    ClearScreen,
+    Return,
+    Jump,
+    Call,
+    SkipIfEqualImmediate,
+    SkipIfNotEqualImmediate,
+    SkipIfEqual,
+    SetImmediate,
+    AddImmediate,
+    Set,
+    Or,
+    And,
+    Xor,
+    Add,
+    Subtract,
+    ShiftRight,
+    SubtractReverse,
+    ShiftLeft,
+    SkipIfNotEqual,
+    SetIndex,
+    JumpOffset,
+    Random,
+    Draw,
+    SkipIfKey,
+    SkipIfNotKey,
+    GetDelayTimer,
+    WaitForKey,
+    SetDelayTimer,
+    SetSoundTimer,
+    AddIndex,
+    SetIndexToCharacter,
+    StoreDecimal,
+    StoreRegisters,
+    LoadRegisters,
+    Unknown,
+    Count
+};
+
+const char* OperationName(const Operation operation);
+
+// A deliberately plain CHIP-8 interpreter that the fuzzer compares Chip against.
+// It works directly on a ChipState and follows the same conventions as Chip:
+// instructions that touch memory, the stack or a key outside their range fault instead of
+// executing, unknown instructions leave PC where it is, and the timers count down when ticks is a
+// multiple of 16.
+class ReferenceChip {
+public:
+    ChipState state;
+
+    // Set by every Step(), used as coverage by the fuzzer.
+    Operation lastOperation = Operation::Unknown;
+    // Something worth telling apart about how the instruction went: the new VF, whether a skip was
+    // taken, whether a sprite collided or wrapped.
+    uint8_t lastOutcome = 0;
+
+    // Returns false if the instruction faulted.
+    bool Step(const uint32_t ticks);
+
+private:
+    bool Draw(const uint8_t x, const uint8_t y, const uint8_t height);
+};
+
+#endif /* reference_hpp */